@@ -13,6 +13,8 @@
 #include <QLabel>
 #include <QSlider>
 
+#include "command_schema.h"
+
 class BluetoothScanner : public QWidget {
     Q_OBJECT
 
@@ -72,7 +74,7 @@ BluetoothScanner::BluetoothScanner(QWidget *parent) : QWidget(parent), controlle
     layout->addWidget(idInput);
 
     idSlider = new QSlider(Qt::Horizontal, this);
-    idSlider->setRange(0, 255);
+    idSlider->setRange(ByteField::minimum(), ByteField::maximum());
     idSlider->setValue(127);
     idSlider->setEnabled(false);
     layout->addWidget(idSlider);
@@ -84,7 +86,7 @@ BluetoothScanner::BluetoothScanner(QWidget *parent) : QWidget(parent), controlle
     layout->addWidget(valueInput);
 
     valueSlider = new QSlider(Qt::Horizontal, this);
-    valueSlider->setRange(0, 255);
+    valueSlider->setRange(ByteField::minimum(), ByteField::maximum());
     valueSlider->setValue(127);
     valueSlider->setEnabled(false);
     layout->addWidget(valueSlider);
@@ -103,7 +105,7 @@ BluetoothScanner::BluetoothScanner(QWidget *parent) : QWidget(parent), controlle
     connect(idInput, &QLineEdit::textChanged, this, [this](const QString &text) {
         bool ok;
         int value = text.toInt(&ok);
-        if (ok && value >= 0 && value <= 255) {
+        if (ok && ByteField::inRange(value)) {
             idSlider->setValue(value);
         }
     });
@@ -115,7 +117,7 @@ BluetoothScanner::BluetoothScanner(QWidget *parent) : QWidget(parent), controlle
     connect(valueInput, &QLineEdit::textChanged, this, [this](const QString &text) {
         bool ok;
         int value = text.toInt(&ok);
-        if (ok && value >= 0 && value <= 255) {
+        if (ok && ByteField::inRange(value)) {
             valueSlider->setValue(value);
         }
     });
@@ -247,14 +249,13 @@ void BluetoothScanner::sendData() {
     int id = idInput->text().toInt(&idOk);
     int value = valueInput->text().toInt(&valueOk);
 
-    if (!idOk || !valueOk || id < 0 || id > 255 || value < 0 || value > 255) {
+    RawCommand::Buffer payload;
+    if (!idOk || !valueOk || !RawCommand::encode(payload, id, value)) {
         QMessageBox::warning(this, "错误", "请输入有效的ID和值 (0-255)");
         return;
     }
 
-    QByteArray data;
-    data.append(static_cast<char>(id));
-    data.append(static_cast<char>(value));
+    const QByteArray data(reinterpret_cast<const char *>(payload.data()), RawCommand::size);
 
     services.begin().value()->writeCharacteristic(writeCharacteristic, data, QLowEnergyService::WriteWithoutResponse);
     // QMessageBox::information(this, "发送状态", QString("已发送数据: ID=%1, Value=%2").arg(id).arg(value));
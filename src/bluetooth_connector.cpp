@@ -1,9 +1,16 @@
 #include "bluetooth_connector.h"
+#include "trace_recorder.h"
+#include "command_schema.h"
 #include <QMessageBox>
+#include <QShortcut>
+#include <QFileDialog>
 
 // 构造函数：初始化 BluetoothConnector 类
 BluetoothConnector::BluetoothConnector(QWidget *parent)
-    : QMainWindow(parent), lastId(0), lastValue(0), currentWriteCharacteristic()
+    : QMainWindow(parent), controller(nullptr), currentService(nullptr),
+      lastId(0), lastValue(0), currentWriteCharacteristic(),
+      fastScanActive(false), matchedDevices(0), traceId(0), awaitingFirstWrite(false),
+      connectSpanOpen(false), discoverSpanOpen(false), motionUploadPending(false)
 {
     setupUI();  // 设置用户界面
     
@@ -11,6 +18,15 @@ BluetoothConnector::BluetoothConnector(QWidget *parent)
     discoveryAgent = new QBluetoothDeviceDiscoveryAgent(this);
     connect(discoveryAgent, &QBluetoothDeviceDiscoveryAgent::deviceDiscovered,
             this, &BluetoothConnector::deviceDiscovered);
+    connect(discoveryAgent, &QBluetoothDeviceDiscoveryAgent::deviceUpdated,
+            this, &BluetoothConnector::deviceUpdated);
+    connect(discoveryAgent, &QBluetoothDeviceDiscoveryAgent::finished,
+            this, &BluetoothConnector::scanFinished);
+    connect(discoveryAgent, &QBluetoothDeviceDiscoveryAgent::canceled,
+            this, &BluetoothConnector::scanFinished);
+    connect(discoveryAgent, QOverload<QBluetoothDeviceDiscoveryAgent::Error>::of(&QBluetoothDeviceDiscoveryAgent::error),
+            this, &BluetoothConnector::scanFinished);
+    defaultScanTimeout = discoveryAgent->lowEnergyDiscoveryTimeout();
             
     // 初始化定时器，用于定期发送数据
     sendTimer = new QTimer(this);
@@ -18,6 +34,24 @@ BluetoothConnector::BluetoothConnector(QWidget *parent)
     connect(sendTimer, &QTimer::timeout, this, &BluetoothConnector::updateAndSendValue);
     
     services.clear();  // 清空服务列表
+    
+    // 初始化 OTA / 配置上传引擎
+    uploader = new GattUploader(this);
+    connect(uploader, &GattUploader::progress, this, &BluetoothConnector::onUploadProgress);
+    connect(uploader, &GattUploader::finished, this, &BluetoothConnector::onUploadFinished);
+    connect(uploader, &GattUploader::failed, this, &BluetoothConnector::onUploadFailed);
+    
+    // 定期读取机器人状态，界面只读缓存
+    poller = new StatePoller(this);
+    connect(poller, &StatePoller::valueUpdated, this, &BluetoothConnector::onStateUpdated);
+    poller->watch(QBluetoothUuid(QBluetoothUuid::BatteryLevel), 5000);
+    poller->watch(QBluetoothUuid(QBluetoothUuid::FirmwareRevisionString), 60000);
+    
+    // 追踪快捷键：Ctrl+Shift+R 开关记录，Ctrl+Shift+T 导出
+    QShortcut *traceToggleShortcut = new QShortcut(QKeySequence("Ctrl+Shift+R"), this);
+    connect(traceToggleShortcut, &QShortcut::activated, this, &BluetoothConnector::toggleTracing);
+    QShortcut *traceDumpShortcut = new QShortcut(QKeySequence("Ctrl+Shift+T"), this);
+    connect(traceDumpShortcut, &QShortcut::activated, this, &BluetoothConnector::dumpTrace);
 }
 
 // 设置用户界面
@@ -31,16 +65,65 @@ void BluetoothConnector::setupUI()
     // 状态标签
     statusLabel = new QLabel("未连接", this);
     statusLabel->setAlignment(Qt::AlignCenter);
+    telemetryLabel = new QLabel("电量: -    固件: -", this);
+    telemetryLabel->setAlignment(Qt::AlignCenter);
     
     // 按钮布局
     QHBoxLayout *buttonLayout = new QHBoxLayout();
     scanButton = new QPushButton("扫描设备", this);
     connectButton = new QPushButton("连接", this);
     disconnectButton = new QPushButton("断开连接", this);
+    uploadButton = new QPushButton("上传固件/配置", this);
     
     buttonLayout->addWidget(scanButton);
     buttonLayout->addWidget(connectButton);
     buttonLayout->addWidget(disconnectButton);
+    buttonLayout->addWidget(uploadButton);
+    
+    // 上传进度
+    uploadProgress = new QProgressBar(this);
+    uploadProgress->setRange(0, 100);
+    uploadProgress->setVisible(false);
+    
+    // 动作程序：编译脚本并整体上传，由固件本地执行
+    QHBoxLayout *programLayout = new QHBoxLayout();
+    loadProgramButton = new QPushButton("加载动作脚本", this);
+    runProgramButton = new QPushButton("运行动作", this);
+    stopProgramButton = new QPushButton("停止动作", this);
+    runProgramButton->setEnabled(false);
+    stopProgramButton->setEnabled(false);
+    
+    programLayout->addWidget(loadProgramButton);
+    programLayout->addWidget(runProgramButton);
+    programLayout->addWidget(stopProgramButton);
+    
+    // 快速扫描：仅 LE，按名称/服务 UUID 过滤，找到目标后立即停止
+    QHBoxLayout *filterLayout = new QHBoxLayout();
+    fastScanCheckBox = new QCheckBox("快速扫描(仅LE)", this);
+    nameFilterEdit = new QLineEdit(this);
+    nameFilterEdit->setPlaceholderText("名称过滤 (正则)");
+    uuidFilterEdit = new QLineEdit(this);
+    uuidFilterEdit->setPlaceholderText("服务 UUID 过滤");
+    
+    filterLayout->addWidget(fastScanCheckBox);
+    filterLayout->addWidget(nameFilterEdit);
+    filterLayout->addWidget(uuidFilterEdit);
+    
+    // 厂商数据过滤与目标数量
+    QHBoxLayout *manufacturerLayout = new QHBoxLayout();
+    manufacturerIdEdit = new QLineEdit(this);
+    manufacturerIdEdit->setPlaceholderText("厂商 ID (十六进制)");
+    manufacturerPrefixEdit = new QLineEdit(this);
+    manufacturerPrefixEdit->setPlaceholderText("厂商数据前缀 (十六进制)");
+    expectedCountSpinBox = new QSpinBox(this);
+    expectedCountSpinBox->setRange(0, 32);
+    expectedCountSpinBox->setValue(1);
+    expectedCountSpinBox->setPrefix("目标数量: ");
+    expectedCountSpinBox->setSpecialValueText("目标数量: 不限");
+    
+    manufacturerLayout->addWidget(manufacturerIdEdit);
+    manufacturerLayout->addWidget(manufacturerPrefixEdit);
+    manufacturerLayout->addWidget(expectedCountSpinBox);
     
     // 初始状态设置
     connectButton->setEnabled(false);
@@ -57,9 +140,9 @@ void BluetoothConnector::setupUI()
     idLabel = new QLabel("默认Forward: 0", this);
     valueLabel = new QLabel("默认Turn: 0", this);
     
-    idSlider->setRange(-100, 100);
+    idSlider->setRange(ForwardField::minimum(), ForwardField::maximum());
     idSlider->setValue(0);
-    valueSlider->setRange(-90, 90);
+    valueSlider->setRange(TurnField::minimum(), TurnField::maximum());
     valueSlider->setValue(0);
     
     // 文本框
@@ -72,7 +155,12 @@ void BluetoothConnector::setupUI()
     
     // 添加所有控件到布局
     mainLayout->addWidget(statusLabel);
+    mainLayout->addWidget(telemetryLabel);
     mainLayout->addLayout(buttonLayout);
+    mainLayout->addLayout(filterLayout);
+    mainLayout->addLayout(manufacturerLayout);
+    mainLayout->addWidget(uploadProgress);
+    mainLayout->addLayout(programLayout);
     mainLayout->addWidget(new QLabel("设备列表:"));
     mainLayout->addWidget(deviceList);
     mainLayout->addWidget(new QLabel("服务列表:"));
@@ -105,6 +193,10 @@ void BluetoothConnector::setupUI()
         }
     });
     connect(disconnectButton, &QPushButton::clicked, this, &BluetoothConnector::disconnectFromDevice);
+    connect(uploadButton, &QPushButton::clicked, this, &BluetoothConnector::startUpload);
+    connect(loadProgramButton, &QPushButton::clicked, this, &BluetoothConnector::loadMotionProgram);
+    connect(runProgramButton, &QPushButton::clicked, this, &BluetoothConnector::runMotionProgram);
+    connect(stopProgramButton, &QPushButton::clicked, this, &BluetoothConnector::stopMotionProgram);
     connect(serviceList, &QListWidget::itemClicked, this, &BluetoothConnector::onServiceSelected);
     connect(characteristicList, &QListWidget::itemClicked, this, &BluetoothConnector::onCharacteristicSelected);
     
@@ -123,23 +215,115 @@ void BluetoothConnector::startScanning()
 {
     deviceList->clear();  // 清空设备列表
     serviceList->clear();  // 清空服务列表
-    discoveryAgent->start();  // 开始设备扫描
+    matchedDevices = 0;
+    TraceRecorder::asyncBegin("scan", 0);
+    
+    fastScanActive = fastScanCheckBox->isChecked();
+    if (fastScanActive) {
+        applyScanFilter();
+        discoveryAgent->setLowEnergyDiscoveryTimeout(3000);  // 目标未出现时最多扫描 3 秒
+        discoveryAgent->start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);  // 仅扫描 BLE 设备
+    } else {
+        discoveryAgent->setLowEnergyDiscoveryTimeout(defaultScanTimeout);
+        discoveryAgent->start();  // 开始设备扫描
+    }
     scanButton->setEnabled(false);  // 禁用扫描按钮
 }
 
+// 根据输入框内容更新扫描过滤器
+void BluetoothConnector::applyScanFilter()
+{
+    scanFilter.clear();
+    
+    const QString nameText = nameFilterEdit->text().trimmed();
+    if (!scanFilter.setNamePattern(nameText)) {
+        qDebug() << "无效的名称过滤:" << nameText;
+    }
+    
+    const QString uuidText = uuidFilterEdit->text().trimmed();
+    if (!uuidText.isEmpty()) {
+        QBluetoothUuid uuid(uuidText);
+        if (uuid.isNull()) {
+            qDebug() << "无效的服务 UUID 过滤:" << uuidText;
+        } else {
+            scanFilter.setServiceUuid(uuid);
+        }
+    }
+    
+    const QString manufacturerText = manufacturerIdEdit->text().trimmed();
+    if (!manufacturerText.isEmpty()) {
+        bool ok;
+        uint id = manufacturerText.toUInt(&ok, 16);
+        if (!ok || id > 0xFFFF) {
+            qDebug() << "无效的厂商 ID 过滤:" << manufacturerText;
+        } else {
+            QByteArray prefix = QByteArray::fromHex(manufacturerPrefixEdit->text().trimmed().toLatin1());
+            scanFilter.setManufacturerData(static_cast<quint16>(id), prefix);
+        }
+    }
+    
+    scanFilter.setExpectedCount(expectedCountSpinBox->value());
+}
+
+// 扫描结束（完成、被停止或出错）
+void BluetoothConnector::scanFinished()
+{
+    TraceRecorder::asyncEnd("scan", 0);
+    scanButton->setEnabled(true);  // 启用扫描按钮
+    qDebug() << "设备扫描结束，共" << deviceList->count() << "个设备";
+}
+
+// 检查设备是否已在列表中
+bool BluetoothConnector::isDeviceListed(const QBluetoothDeviceInfo &device) const
+{
+    for (int i = 0; i < deviceList->count(); ++i) {
+        const QBluetoothDeviceInfo listed = deviceList->item(i)->data(Qt::UserRole).value<QBluetoothDeviceInfo>();
+        if (listed.address() == device.address() && listed.deviceUuid() == device.deviceUuid())
+            return true;
+    }
+    return false;
+}
+
 // 处理发现的设备
 void BluetoothConnector::deviceDiscovered(const QBluetoothDeviceInfo &device)
 {
+    if (fastScanActive && !scanFilter.matches(device)) return;  // 过滤掉非目标设备
+    
     QString label = QString("%1 (%2)").arg(device.name()).arg(device.address().toString());
     QListWidgetItem *item = new QListWidgetItem(label);
     item->setData(Qt::UserRole, QVariant::fromValue(device));
     deviceList->addItem(item);  // 将设备添加到列表
+    
+    // 目标设备都已找到，提前结束扫描；未设置过滤条件时不提前结束
+    if (fastScanActive && scanFilter.isActive() && scanFilter.expectedCount() > 0
+            && ++matchedDevices >= scanFilter.expectedCount()) {
+        qDebug() << "已找到目标设备，停止扫描";
+        discoveryAgent->stop();
+    }
+}
+
+// 广播数据更新：服务 UUID 或厂商数据可能在扫描响应中才出现
+void BluetoothConnector::deviceUpdated(const QBluetoothDeviceInfo &device, QBluetoothDeviceInfo::Fields updatedFields)
+{
+    Q_UNUSED(updatedFields);
+    if (!fastScanActive || !discoveryAgent->isActive()) return;
+    if (!isDeviceListed(device)) {
+        deviceDiscovered(device);
+    }
 }
 
 // 连接到选定的设备
 void BluetoothConnector::connectToDevice(QListWidgetItem *item)
 {
     if (!item) return;
+    TRACE_SCOPE("connectToDevice");
+    
+    endConnectionSpans();  // 重试连接时先结束上一次未完成的阶段
+    ++traceId;
+    awaitingFirstWrite = true;
+    connectSpanOpen = true;
+    TraceRecorder::asyncBegin("connect", traceId);
+    TraceRecorder::asyncBegin("awaitFirstWrite", traceId);
     
     QBluetoothDeviceInfo device = item->data(Qt::UserRole).value<QBluetoothDeviceInfo>();
     controller = QLowEnergyController::createCentral(device, this);
@@ -161,11 +345,16 @@ void BluetoothConnector::connectToDevice(QListWidgetItem *item)
 // 处理发现的服务
 void BluetoothConnector::serviceDiscovered(const QBluetoothUuid &uuid)
 {
+    TRACE_SCOPE("serviceDiscovered");
     qDebug() << "发现服务 UUID:" << uuid.toString();
     QLowEnergyService *service = controller->createServiceObject(uuid, this);
     if (service) {
         services.insert(uuid, service);
+        detailSpansOpen.insert(uuid);
+        TraceRecorder::asyncBegin("discoverDetails", detailSpanId(uuid));
         connect(service, &QLowEnergyService::stateChanged, this, &BluetoothConnector::serviceDetailsDiscovered);
+        connect(service, QOverload<QLowEnergyService::ServiceError>::of(&QLowEnergyService::error),
+                this, &BluetoothConnector::serviceError);
         service->discoverDetails();  // 开始发现服务的详细信息
         
         // 添加服务到列表
@@ -180,6 +369,10 @@ void BluetoothConnector::serviceDiscovered(const QBluetoothUuid &uuid)
 // 服务扫描完成
 void BluetoothConnector::serviceScanDone()
 {
+    if (discoverSpanOpen) {
+        discoverSpanOpen = false;
+        TraceRecorder::asyncEnd("discoverServices", traceId);
+    }
     scanButton->setEnabled(true);  // 启用扫描按钮
     qDebug() << "服务扫描完成";
 }
@@ -219,6 +412,8 @@ void BluetoothConnector::serviceDetailsDiscovered(QLowEnergyService::ServiceStat
     if (newState == QLowEnergyService::ServiceDiscovered) {
         QLowEnergyService *service = qobject_cast<QLowEnergyService*>(sender());
         if (service) {
+            TRACE_SCOPE("serviceDetailsDiscovered");
+            endDetailSpan(service->serviceUuid());
             qDebug() << "服务已完全发现，UUID:" << service->serviceUuid().toString();
             
             // 获取并显示特征
@@ -230,22 +425,36 @@ void BluetoothConnector::serviceDetailsDiscovered(QLowEnergyService::ServiceStat
                 // serviceList->addItem(charItem);
                 qDebug() << "发现特征 UUID:" << characteristic.uuid().toString();
 
-                // 检查特征是否可写，并将其赋值给 currentWriteCharacteristic
-                if (characteristic.isValid() && (characteristic.properties() & QLowEnergyCharacteristic::Write)) {
+                // 检查特征是否可写，并将其赋值给 currentWriteCharacteristic（上传服务的特征除外）
+                if (characteristic.isValid() && (characteristic.properties() & QLowEnergyCharacteristic::Write)
+                        && service->serviceUuid() != GattUploader::serviceUuid()) {
                     currentWriteCharacteristic = characteristic;
                     qDebug() << "Selected writable Characteristic UUID:" << characteristic.uuid().toString();
                     // 如果只需要第一个可写特征，可以在这里 break;
                 }
             }
+            
+            resumeUpload(service);  // 断线前未完成的上传在此续传
+            poller->addService(service);
         }
     } else {
         qDebug() << "服务未完全发现，状态:" << newState;
     }
 }
 
+// 服务出错：详细信息发现失败时结束对应的追踪阶段
+void BluetoothConnector::serviceError(QLowEnergyService::ServiceError error)
+{
+    QLowEnergyService *service = qobject_cast<QLowEnergyService*>(sender());
+    if (!service) return;
+    qDebug() << "服务错误:" << service->serviceUuid().toString() << error;
+    endDetailSpan(service->serviceUuid());
+}
+
 // 更新并发送滑块的值
 void BluetoothConnector::updateAndSendValue()
 {
+    TRACE_SCOPE("updateAndSendValue");
     sendTimer->stop();  // 停止定时器
     
     if (!currentService || !currentWriteCharacteristic.isValid()) return; // 检查特征有效性
@@ -253,14 +462,7 @@ void BluetoothConnector::updateAndSendValue()
     int currentId = idSlider->value();
     int currentValue = valueSlider->value();
     
-    // 创建要发送的数据数组
-    QByteArray data;
-    data.append(static_cast<char>(currentId));
-    data.append(static_cast<char>(currentValue));
-    
-    // 使用当前的可写特征发送数据
-    currentService->writeCharacteristic(currentWriteCharacteristic, data);
-    qDebug() << "发送数据: " << data.toHex();
+    if (!writeMotionCommand(currentId, currentValue)) return;
     
     lastId = currentId;
     lastValue = currentValue;
@@ -270,6 +472,13 @@ void BluetoothConnector::updateAndSendValue()
 void BluetoothConnector::disconnectFromDevice()
 {
     if (controller) {
+        // 主动断开时放弃未完成的上传；只有意外断线才保留进度等待续传
+        const GattUploader::State uploadState = uploader->state();
+        uploader->abort();
+        if (uploadState != uploader->state()) {
+            motionUploadPending = false;
+            uploadProgress->setFormat("上传已取消");
+        }
         controller->disconnectFromDevice();
         statusLabel->setText("已断开连接");
         connectButton->setEnabled(true);
@@ -281,6 +490,7 @@ void BluetoothConnector::disconnectFromDevice()
 // 处理控制器错误
 void BluetoothConnector::handleControllerError(QLowEnergyController::Error error)
 {
+    endConnectionSpans();
     QString errorString;
     switch (error) {
         case QLowEnergyController::UnknownError:
@@ -304,12 +514,20 @@ void BluetoothConnector::handleControllerError(QLowEnergyController::Error error
 // 处理连接状态变化
 void BluetoothConnector::handleConnectionStateChanged(QLowEnergyController::ControllerState state)
 {
+    TRACE_SCOPE("handleConnectionStateChanged");
     switch (state) {
         case QLowEnergyController::UnconnectedState:
             qDebug() << "Unconnected";
             statusLabel->setText("未连接");
             connectButton->setEnabled(true);
             disconnectButton->setEnabled(false);
+            uploader->pause();  // 意外断线：保留上传进度，重连同一设备后续传
+            poller->clearServices();
+            telemetryLabel->setText("电量: -    固件: -");
+            // 动作程序只对本次连接中上传完成的设备有效，重新上传后再启用
+            runProgramButton->setEnabled(false);
+            stopProgramButton->setEnabled(false);
+            endConnectionSpans();
             break;
         case QLowEnergyController::ConnectingState:
             qDebug() << "Connecting...";
@@ -321,6 +539,10 @@ void BluetoothConnector::handleConnectionStateChanged(QLowEnergyController::Cont
             statusLabel->setText("已连接");
             connectButton->setEnabled(false);
             disconnectButton->setEnabled(true);
+            connectSpanOpen = false;
+            discoverSpanOpen = true;
+            TraceRecorder::asyncEnd("connect", traceId);
+            TraceRecorder::asyncBegin("discoverServices", traceId);
             controller->discoverServices();  // 开始发现服务
             break;
         case QLowEnergyController::DiscoveringState:
@@ -361,6 +583,7 @@ void BluetoothConnector::onCharacteristicSelected(QListWidgetItem *item)
 // 发送消息
 void BluetoothConnector::sendMessage()
 {
+    TRACE_SCOPE("sendMessage");
     qDebug() <<"currentService:" << currentService;
     qDebug() <<"currentWriteCharacteristic:" << currentWriteCharacteristic.isValid();
     if (!currentService || !currentWriteCharacteristic.isValid()) {
@@ -368,13 +591,63 @@ void BluetoothConnector::sendMessage()
         return;
     }
     
-    QByteArray data;
-    data.append(static_cast<char>(idSlider->value()));
-    data.append(static_cast<char>(valueSlider->value()));
+    writeMotionCommand(idSlider->value(), valueSlider->value());
+}
+
+// 按 MotionCommand 格式编码到栈缓冲区，并通过当前的可写特征发送
+bool BluetoothConnector::writeMotionCommand(int forward, int turn)
+{
+    MotionCommand::Buffer payload;
+    if (!MotionCommand::encode(payload, forward, turn)) {
+        qDebug() << "运动命令超出范围:" << forward << turn;
+        return false;
+    }
     
-    // 使用当前的可写特征发送数据
+    const QByteArray data(reinterpret_cast<const char *>(payload.data()), MotionCommand::size);
     currentService->writeCharacteristic(currentWriteCharacteristic, data);
+    traceFirstWrite();
     qDebug() << "发送数据: " << data.toHex();
+    return true;
+}
+
+// 连接后的第一次写入，结束 awaitFirstWrite 阶段
+void BluetoothConnector::traceFirstWrite()
+{
+    if (!awaitingFirstWrite) return;
+    awaitingFirstWrite = false;
+    TraceRecorder::asyncEnd("awaitFirstWrite", traceId);
+}
+
+// 连接失败或断开时结束仍未完成的异步阶段
+void BluetoothConnector::endConnectionSpans()
+{
+    if (connectSpanOpen) {
+        connectSpanOpen = false;
+        TraceRecorder::asyncEnd("connect", traceId);
+    }
+    if (discoverSpanOpen) {
+        discoverSpanOpen = false;
+        TraceRecorder::asyncEnd("discoverServices", traceId);
+    }
+    if (awaitingFirstWrite) {
+        awaitingFirstWrite = false;
+        TraceRecorder::asyncEnd("awaitFirstWrite", traceId);
+    }
+    for (const QBluetoothUuid &uuid : detailSpansOpen)
+        TraceRecorder::asyncEnd("discoverDetails", detailSpanId(uuid));
+    detailSpansOpen.clear();
+}
+
+void BluetoothConnector::endDetailSpan(const QBluetoothUuid &serviceUuid)
+{
+    if (detailSpansOpen.remove(serviceUuid))
+        TraceRecorder::asyncEnd("discoverDetails", detailSpanId(serviceUuid));
+}
+
+// 每个服务的详细信息发现使用独立的异步 ID，高 32 位区分连接
+quint64 BluetoothConnector::detailSpanId(const QBluetoothUuid &serviceUuid) const
+{
+    return (traceId << 32) ^ qHash(serviceUuid);
 }
 
 // 析构函数：清理资源
@@ -401,7 +674,7 @@ void BluetoothConnector::updateIdFromLineEdit()
 {
     bool ok;
     int value = idLineEdit->text().toInt(&ok);
-    if (ok && value >= -100 && value <= 100) {
+    if (ok && ForwardField::inRange(value)) {
         idSlider->setValue(value);
     }
 }
@@ -410,7 +683,7 @@ void BluetoothConnector::updateValueFromLineEdit()
 {
     bool ok;
     int value = valueLineEdit->text().toInt(&ok);
-    if (ok && value >= -90 && value <= 90) {
+    if (ok && TurnField::inRange(value)) {
         valueSlider->setValue(value);
     }
 } 
@@ -425,4 +698,244 @@ void BluetoothConnector::centerValue()
 {
     valueSlider->setValue(0);
     valueLineEdit->setText(QString::number(0));
-}
\ No newline at end of file
+}
+
+void BluetoothConnector::toggleTracing()
+{
+    TraceRecorder::setEnabled(!TraceRecorder::isEnabled());
+    qDebug() << "连接时序追踪:" << (TraceRecorder::isEnabled() ? "开启" : "关闭");
+}
+
+// 导出追踪数据到当前目录；不清空缓冲区，BLE_TRACE 退出时的导出仍包含全部事件
+void BluetoothConnector::dumpTrace()
+{
+    TraceRecorder::dump("ble_trace.json");
+}
+
+// 按固定 UUID 查找上传服务中的控制特征和数据特征（见 gatt_uploader.h）
+bool BluetoothConnector::findUploadCharacteristics(QLowEnergyService *service,
+                                                   QLowEnergyCharacteristic &control,
+                                                   QLowEnergyCharacteristic &data) const
+{
+    control = QLowEnergyCharacteristic();
+    data = QLowEnergyCharacteristic();
+    if (!service || service->serviceUuid() != GattUploader::serviceUuid()) return false;
+    
+    control = service->characteristic(GattUploader::controlCharacteristicUuid());
+    data = service->characteristic(GattUploader::dataCharacteristicUuid());
+    return control.isValid() && (control.properties() & QLowEnergyCharacteristic::Write)
+            && (control.properties() & QLowEnergyCharacteristic::Notify)
+            && data.isValid() && (data.properties()
+                    & (QLowEnergyCharacteristic::Write | QLowEnergyCharacteristic::WriteNoResponse));
+}
+
+// 查找设备上的上传服务
+QLowEnergyService *BluetoothConnector::findUploadService(QLowEnergyCharacteristic &control,
+                                                         QLowEnergyCharacteristic &data) const
+{
+    QLowEnergyService *service = services.value(GattUploader::serviceUuid());
+    return findUploadCharacteristics(service, control, data) ? service : nullptr;
+}
+
+// 选择文件并开始上传
+void BluetoothConnector::startUpload()
+{
+    if (!controller || controller->state() != QLowEnergyController::DiscoveredState) {
+        QMessageBox::warning(this, "错误", "请先连接设备并完成服务发现");
+        return;
+    }
+    
+    QLowEnergyCharacteristic control;
+    QLowEnergyCharacteristic data;
+    QLowEnergyService *service = findUploadService(control, data);
+    if (!service) {
+        QMessageBox::warning(this, "错误", "设备上未找到上传服务");
+        return;
+    }
+    
+    QString path = QFileDialog::getOpenFileName(this, "选择固件或配置文件", QString(),
+                                                "固件 (*.bin);;配置 (*.json *.cfg);;所有文件 (*)");
+    if (path.isEmpty()) return;
+    
+    uploader->abort();
+    GattUploader::Target target = path.endsWith(".bin", Qt::CaseInsensitive)
+            ? GattUploader::Firmware : GattUploader::Config;
+    if (!uploader->openFile(path, target)) {
+        QMessageBox::warning(this, "错误", "无法打开文件: " + path);
+        return;
+    }
+    
+    motionUploadPending = false;
+    uploadDeviceId = currentDeviceId();
+    uploader->setMtu(currentMtu());
+    uploader->start(service, control, data);
+    uploadProgress->setValue(0);
+    uploadProgress->setFormat("%p%");
+    uploadProgress->setVisible(true);
+    qDebug() << "开始上传:" << path << "MTU:" << currentMtu();
+}
+
+// 当前连接的 ATT MTU；Qt 5.14 之前无法查询，按 BLE 默认值 23 处理
+int BluetoothConnector::currentMtu() const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    return controller ? controller->mtu() : 23;
+#else
+    return 23;
+#endif
+}
+
+// 当前连接设备的标识；macOS 上没有蓝牙地址，改用系统分配的设备 UUID
+QString BluetoothConnector::currentDeviceId() const
+{
+    if (!controller) return QString();
+    return controller->remoteAddress().isNull()
+            ? controller->remoteDeviceUuid().toString()
+            : controller->remoteAddress().toString();
+}
+
+// 重连同一设备且服务发现完成时，从设备报告的偏移处继续上传
+void BluetoothConnector::resumeUpload(QLowEnergyService *service)
+{
+    if (uploader->state() != GattUploader::Paused) return;
+    if (currentDeviceId() != uploadDeviceId) {
+        qDebug() << "当前设备不是上传中断的设备，不续传";
+        return;
+    }
+    
+    QLowEnergyCharacteristic control;
+    QLowEnergyCharacteristic data;
+    if (!findUploadCharacteristics(service, control, data)) return;
+    
+    qDebug() << "重连后续传，已确认" << uploader->ackedBytes() << "字节";
+    uploader->setMtu(currentMtu());
+    uploader->start(service, control, data);
+}
+
+void BluetoothConnector::onUploadProgress(qint64 ackedBytes, qint64 totalBytes, double bytesPerSecond)
+{
+    int percent = totalBytes > 0 ? static_cast<int>(ackedBytes * 100 / totalBytes) : 100;
+    uploadProgress->setValue(percent);
+    uploadProgress->setFormat(QString("%p%  %1 KB/s").arg(bytesPerSecond / 1024.0, 0, 'f', 1));
+}
+
+void BluetoothConnector::onUploadFinished()
+{
+    uploadProgress->setValue(100);
+    uploadProgress->setFormat("上传完成");
+    
+    if (motionUploadPending) {
+        motionUploadPending = false;
+        runProgramButton->setEnabled(true);
+        stopProgramButton->setEnabled(true);
+    }
+}
+
+void BluetoothConnector::onUploadFailed(const QString &reason)
+{
+    uploadProgress->setFormat("上传失败");
+    motionUploadPending = false;
+    QMessageBox::warning(this, "错误", "上传失败: " + reason);
+}
+
+// 编译动作脚本并一次性上传
+void BluetoothConnector::loadMotionProgram()
+{
+    if (!controller || controller->state() != QLowEnergyController::DiscoveredState) {
+        QMessageBox::warning(this, "错误", "请先连接设备并完成服务发现");
+        return;
+    }
+    
+    const GattUploader::State state = uploader->state();
+    if (state == GattUploader::Starting || state == GattUploader::Streaming
+            || state == GattUploader::Finishing || state == GattUploader::Paused) {
+        QMessageBox::warning(this, "错误", "已有上传正在进行");
+        return;
+    }
+    
+    QLowEnergyCharacteristic control;
+    QLowEnergyCharacteristic data;
+    QLowEnergyService *service = findUploadService(control, data);
+    if (!service) {
+        QMessageBox::warning(this, "错误", "设备上未找到上传服务");
+        return;
+    }
+    
+    QString path = QFileDialog::getOpenFileName(this, "选择动作脚本", QString(),
+                                                "动作脚本 (*.motion *.txt);;所有文件 (*)");
+    if (path.isEmpty()) return;
+    
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QMessageBox::warning(this, "错误", "无法打开文件: " + path);
+        return;
+    }
+    
+    QByteArray bytecode;
+    QString error;
+    if (!MotionProgram::compile(QString::fromUtf8(file.readAll()), bytecode, &error)) {
+        QMessageBox::warning(this, "编译错误", error);
+        return;
+    }
+    qDebug() << "动作脚本已编译:" << bytecode.size() << "字节";
+    
+    runProgramButton->setEnabled(false);
+    stopProgramButton->setEnabled(false);
+    motionUploadPending = true;
+    uploadDeviceId = currentDeviceId();
+    uploader->setData(bytecode, GattUploader::MotionProgram);
+    uploader->setMtu(currentMtu());
+    uploader->start(service, control, data);
+    uploadProgress->setValue(0);
+    uploadProgress->setFormat("%p%");
+    uploadProgress->setVisible(true);
+}
+
+void BluetoothConnector::runMotionProgram()
+{
+    sendMotionCommand(MotionProgram::Run);
+}
+
+// 停止动作程序，恢复滑块实时控制
+void BluetoothConnector::stopMotionProgram()
+{
+    sendMotionCommand(MotionProgram::Stop);
+}
+
+void BluetoothConnector::sendMotionCommand(MotionProgram::Command command)
+{
+    QLowEnergyCharacteristic control;
+    QLowEnergyCharacteristic data;
+    QLowEnergyService *service = findUploadService(control, data);
+    if (!service) {
+        qDebug() << "无法发送动作命令：未找到控制特征";
+        return;
+    }
+    
+    service->writeCharacteristic(control, MotionProgram::command(command));
+    qDebug() << "发送动作命令:" << MotionProgram::command(command).toHex();
+}
+
+// 状态缓存更新：从缓存组装显示内容，不触发额外读取
+void BluetoothConnector::onStateUpdated(const QBluetoothUuid &characteristic, const QByteArray &value, qint64 timestamp)
+{
+    Q_UNUSED(timestamp);
+    qDebug() << "状态更新:" << characteristic.toString() << value.toHex();
+    
+    QString battery = "-";
+    const StatePoller::CachedValue batteryValue = poller->value(QBluetoothUuid(QBluetoothUuid::BatteryLevel));
+    int level;
+    if (batteryValue.isValid()
+            && BatteryLevelTelemetry::decode(reinterpret_cast<const std::uint8_t *>(batteryValue.value.constData()),
+                                             batteryValue.value.size(), level)) {
+        battery = QString("%1%").arg(level);
+    }
+    
+    QString firmware = "-";
+    const StatePoller::CachedValue firmwareValue = poller->value(QBluetoothUuid(QBluetoothUuid::FirmwareRevisionString));
+    if (firmwareValue.isValid()) {
+        firmware = QString::fromUtf8(firmwareValue.value);
+    }
+    
+    telemetryLabel->setText(QString("电量: %1    固件: %2").arg(battery, firmware));
+}
@@ -11,6 +11,15 @@
 #include <QVBoxLayout>
 #include <QTimer>
 #include <QMap>
+#include <QSet>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QProgressBar>
+
+#include "scan_filter.h"
+#include "gatt_uploader.h"
+#include "motion_program.h"
+#include "state_poller.h"
 
 class BluetoothConnector : public QMainWindow {
     Q_OBJECT
@@ -21,21 +30,34 @@ public:
 
 private slots:
     void deviceDiscovered(const QBluetoothDeviceInfo &device);
+    void deviceUpdated(const QBluetoothDeviceInfo &device, QBluetoothDeviceInfo::Fields updatedFields);
+    void scanFinished();
     void connectToDevice(QListWidgetItem *item);
     void disconnectFromDevice();
     void serviceDiscovered(const QBluetoothUuid &uuid);
     void serviceScanDone();
     void serviceDetailsDiscovered(QLowEnergyService::ServiceState newState);
+    void serviceError(QLowEnergyService::ServiceError error);
     void onServiceSelected(QListWidgetItem *item);
     void updateAndSendValue();
     void handleControllerError(QLowEnergyController::Error error);
     void handleConnectionStateChanged(QLowEnergyController::ControllerState state);
     void onCharacteristicSelected(QListWidgetItem *item);
     void sendMessage();
+    void startUpload();
+    void onUploadProgress(qint64 ackedBytes, qint64 totalBytes, double bytesPerSecond);
+    void onUploadFinished();
+    void onUploadFailed(const QString &reason);
+    void loadMotionProgram();
+    void runMotionProgram();
+    void stopMotionProgram();
+    void onStateUpdated(const QBluetoothUuid &characteristic, const QByteArray &value, qint64 timestamp);
 
 private:
     void setupUI();
     void startScanning();
+    void applyScanFilter();
+    bool isDeviceListed(const QBluetoothDeviceInfo &device) const;
     void updateConnectionStatus(const QString &status);
     void updateIdFromSlider(int value);
     void updateValueFromSlider(int value);
@@ -43,6 +65,22 @@ private:
     void updateIdFromLineEdit();
     void centerId();
     void centerValue();
+    void toggleTracing();
+    void dumpTrace();
+    void traceFirstWrite();
+    void endConnectionSpans();
+    void endDetailSpan(const QBluetoothUuid &serviceUuid);
+    quint64 detailSpanId(const QBluetoothUuid &serviceUuid) const;
+    bool writeMotionCommand(int forward, int turn);
+    bool findUploadCharacteristics(QLowEnergyService *service,
+                                   QLowEnergyCharacteristic &control,
+                                   QLowEnergyCharacteristic &data) const;
+    QLowEnergyService *findUploadService(QLowEnergyCharacteristic &control,
+                                         QLowEnergyCharacteristic &data) const;
+    void resumeUpload(QLowEnergyService *service);
+    int currentMtu() const;
+    QString currentDeviceId() const;
+    void sendMotionCommand(MotionProgram::Command command);
 
 
     QBluetoothDeviceDiscoveryAgent *discoveryAgent;
@@ -55,6 +93,17 @@ private:
     QPushButton *scanButton;
     QPushButton *connectButton;
     QPushButton *disconnectButton;
+    QPushButton *uploadButton;
+    QProgressBar *uploadProgress;
+    QPushButton *loadProgramButton;
+    QPushButton *runProgramButton;
+    QPushButton *stopProgramButton;
+    QCheckBox *fastScanCheckBox;
+    QLineEdit *nameFilterEdit;
+    QLineEdit *uuidFilterEdit;
+    QLineEdit *manufacturerIdEdit;
+    QLineEdit *manufacturerPrefixEdit;
+    QSpinBox *expectedCountSpinBox;
     QSlider *idSlider;
     QSlider *valueSlider;
     QLineEdit *idLineEdit;
@@ -62,6 +111,7 @@ private:
     QLabel *idLabel;
     QLabel *valueLabel;
     QLabel *statusLabel;
+    QLabel *telemetryLabel;
     
     int lastId;
     int lastValue;
@@ -69,4 +119,17 @@ private:
     QMap<QBluetoothUuid, QList<QLowEnergyCharacteristic>> serviceCharacteristics;
     QLowEnergyCharacteristic currentWriteCharacteristic;
     QMap<QBluetoothUuid, QLowEnergyService*> services;
+    ScanFilter scanFilter;
+    bool fastScanActive;        // 扫描开始时的模式，扫描中切换复选框不影响本次过滤
+    int matchedDevices;
+    int defaultScanTimeout;
+    quint64 traceId;            // 当前连接的追踪 ID，用于关联异步阶段
+    bool awaitingFirstWrite;
+    bool connectSpanOpen;
+    bool discoverSpanOpen;
+    QSet<QBluetoothUuid> detailSpansOpen;  // 尚未完成详细信息发现的服务
+    GattUploader *uploader;
+    bool motionUploadPending;
+    QString uploadDeviceId;     // 上传所属的设备，只在重连同一设备时续传
+    StatePoller *poller;
 }; 
\ No newline at end of file
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// 编译期命令格式定义：每个字段给出线上类型、取值范围和缩放比例，
+// 由模板生成写入固定栈缓冲区的编码器和对应的解码器（小端字节序，不分配堆内存）
+//
+// 用法：
+//   MotionCommand::Buffer buffer;
+//   if (MotionCommand::encode(buffer, forward, turn)) { ... }
+//
+// 新增机器人或执行器时只需在文件末尾添加新的 Field / Message 定义
+
+// 字段：value 为界面上的数值，线上值为 value * ScaleNum / ScaleDen（四舍五入）
+// 带缩放的字段可以用 double 编码/解码以保留小数精度；用 int 解码时四舍五入到整数
+template <typename Wire, int Min, int Max, int ScaleNum = 1, int ScaleDen = 1>
+struct Field {
+    typedef Wire WireType;
+
+    static_assert(std::is_integral<Wire>::value, "字段的线上类型必须是整数");
+    static_assert(Min <= Max, "字段范围无效");
+    static_assert(ScaleNum > 0 && ScaleDen > 0, "缩放比例必须为正数");
+    static_assert(static_cast<long long>(Min) * ScaleNum / ScaleDen
+                      >= static_cast<long long>(std::numeric_limits<Wire>::min())
+                  && static_cast<long long>(Max) * ScaleNum / ScaleDen
+                      <= static_cast<long long>(std::numeric_limits<Wire>::max()),
+                  "字段范围超出线上类型的表示范围");
+
+    static constexpr std::size_t size = sizeof(Wire);
+
+    static constexpr int minimum() { return Min; }
+    static constexpr int maximum() { return Max; }
+
+    // 整数按 long long 比较，避免无符号类型与负数范围比较出错
+    template <typename Value>
+    static constexpr bool inRange(Value value)
+    {
+        return static_cast<typename std::conditional<std::is_floating_point<Value>::value,
+                                                      double, long long>::type>(value) >= Min
+            && static_cast<typename std::conditional<std::is_floating_point<Value>::value,
+                                                     double, long long>::type>(value) <= Max;
+    }
+
+    template <typename Value>
+    static long long toWire(Value value)
+    {
+        return std::llround(static_cast<double>(value) * ScaleNum / ScaleDen);
+    }
+
+    template <typename Value>
+    static Value fromWire(long long wire)
+    {
+        const double scaled = static_cast<double>(wire) * ScaleDen / ScaleNum;
+        return static_cast<Value>(std::is_floating_point<Value>::value ? scaled : std::round(scaled));
+    }
+};
+
+namespace schema_detail {
+
+template <typename Wire>
+inline void writeLittleEndian(std::uint8_t *out, long long value)
+{
+    typedef typename std::make_unsigned<Wire>::type Unsigned;
+    const Unsigned bits = static_cast<Unsigned>(static_cast<Wire>(value));
+    for (std::size_t i = 0; i < sizeof(Wire); ++i)
+        out[i] = static_cast<std::uint8_t>(bits >> (8 * i));
+}
+
+template <typename Wire>
+inline long long readLittleEndian(const std::uint8_t *in)
+{
+    typedef typename std::make_unsigned<Wire>::type Unsigned;
+    Unsigned bits = 0;
+    for (std::size_t i = 0; i < sizeof(Wire); ++i)
+        bits = static_cast<Unsigned>(bits | (static_cast<Unsigned>(in[i]) << (8 * i)));
+    return static_cast<Wire>(bits);
+}
+
+template <typename... Fields>
+struct TotalSize;
+
+template <>
+struct TotalSize<> {
+    static constexpr std::size_t value = 0;
+};
+
+template <typename F, typename... Rest>
+struct TotalSize<F, Rest...> {
+    static constexpr std::size_t value = F::size + TotalSize<Rest...>::value;
+};
+
+// 按字段顺序逐个编码/解码，Offset 为当前字段在缓冲区中的位置
+template <std::size_t Offset, typename... Fields>
+struct Codec;
+
+template <std::size_t Offset>
+struct Codec<Offset> {
+    static bool encode(std::uint8_t *) { return true; }
+    static bool decode(const std::uint8_t *) { return true; }
+};
+
+template <std::size_t Offset, typename F, typename... Rest>
+struct Codec<Offset, F, Rest...> {
+    template <typename Value, typename... Values>
+    static bool encode(std::uint8_t *out, Value value, Values... rest)
+    {
+        if (!F::inRange(value)) return false;
+        writeLittleEndian<typename F::WireType>(out + Offset, F::toWire(value));
+        return Codec<Offset + F::size, Rest...>::encode(out, rest...);
+    }
+
+    template <typename Value, typename... Values>
+    static bool decode(const std::uint8_t *in, Value &value, Values &... rest)
+    {
+        value = F::template fromWire<Value>(readLittleEndian<typename F::WireType>(in + Offset));
+        if (!F::inRange(value)) return false;
+        return Codec<Offset + F::size, Rest...>::decode(in, rest...);
+    }
+};
+
+} // namespace schema_detail
+
+// 消息：若干字段顺序排列，编码结果写入固定大小的 Buffer
+template <typename... Fields>
+struct Message {
+    static constexpr std::size_t size = schema_detail::TotalSize<Fields...>::value;
+    typedef std::array<std::uint8_t, size> Buffer;
+
+    // 任一字段超出范围时返回 false，此时缓冲区内容无效
+    template <typename... Values>
+    static bool encode(Buffer &out, Values... values)
+    {
+        static_assert(sizeof...(Values) == sizeof...(Fields), "参数个数与字段个数不一致");
+        return schema_detail::Codec<0, Fields...>::encode(out.data(), values...);
+    }
+
+    // 长度不符或任一字段超出范围时返回 false
+    template <typename... Values>
+    static bool decode(const std::uint8_t *data, std::size_t length, Values &... values)
+    {
+        static_assert(sizeof...(Values) == sizeof...(Fields), "参数个数与字段个数不一致");
+        return length == size && schema_detail::Codec<0, Fields...>::decode(data, values...);
+    }
+};
+
+// ---- 控制命令 ----
+
+// 折纸爬行机器人：前进速度与转向角
+typedef Field<std::int8_t, -100, 100> ForwardField;
+typedef Field<std::int8_t, -90, 90> TurnField;
+typedef Message<ForwardField, TurnField> MotionCommand;
+static_assert(MotionCommand::size == 2, "固件按 2 字节解析运动命令");
+
+// 通用调试命令：原始 ID 与值
+typedef Field<std::uint8_t, 0, 255> ByteField;
+typedef Message<ByteField, ByteField> RawCommand;
+static_assert(RawCommand::size == 2, "固件按 2 字节解析原始命令");
+
+// 动作程序指令的操作数（见 motion_program.h）
+typedef Field<std::uint16_t, 0, 65535> DurationField;
+typedef Field<std::uint16_t, 1, 65535> HoldField;
+typedef Field<std::uint8_t, 0, 255> LoopCountField;  // 0 表示无限循环
+typedef Message<ForwardField, TurnField, DurationField> KeyframeOperands;
+typedef Message<HoldField> HoldOperands;
+typedef Message<LoopCountField> LoopOperands;
+static_assert(KeyframeOperands::size == 4, "KEY 指令操作数为 4 字节");
+
+// ---- 遥测 ----
+
+// 标准电池电量特征 0x2A19：百分比
+typedef Message<Field<std::uint8_t, 0, 100> > BatteryLevelTelemetry;
@@ -0,0 +1,459 @@
+#include "gatt_uploader.h"
+#include "trace_recorder.h"
+#include <QLowEnergyDescriptor>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+enum Opcode : quint8 {
+    OpBegin = 0x01,
+    OpData = 0x02,
+    OpBlockEnd = 0x03,
+    OpFinish = 0x04,
+    OpAbort = 0x05,
+    OpReady = 0x81,
+    OpBlockAck = 0x82,
+    OpBlockNak = 0x83,
+    OpDone = 0x84,
+    OpError = 0x85
+};
+
+const int kAttHeaderSize = 3;   // ATT 写操作的操作码和句柄
+const int kDataHeaderSize = 5;  // DATA 包的操作码和偏移
+const int kBlockSize = 4096;    // 每块单独校验和确认
+const int kWindowBlocks = 4;    // 未确认的块最多几个
+const int kAckTimeoutMs = 2000;
+const int kPacketMs = 8;           // 无响应写时每个包的发送时间估计
+const int kResponsePacketMs = 60;  // 有响应写需要一次往返，至少两个连接间隔
+const int kMaxRetries = 5;
+
+void putUint32(char *out, quint32 value)
+{
+    qToLittleEndian<quint32>(value, reinterpret_cast<uchar *>(out));
+}
+
+} // namespace
+
+GattUploader::GattUploader(QObject *parent)
+    : QObject(parent), source(nullptr), size(0), imageCrc(0), target(Firmware), mtu(23),
+      dataWriteMode(QLowEnergyService::WriteWithoutResponse), writeInFlight(false),
+      currentState(Idle), sendOffset(0), ackedOffset(0), retries(0), sessionStartOffset(0)
+{
+    ackTimer = new QTimer(this);
+    ackTimer->setSingleShot(true);
+    ackTimer->setInterval(kAckTimeoutMs);
+    connect(ackTimer, &QTimer::timeout, this, &GattUploader::ackTimeout);
+}
+
+GattUploader::~GattUploader()
+{
+    releaseSource();
+}
+
+QBluetoothUuid GattUploader::serviceUuid()
+{
+    return QBluetoothUuid(QStringLiteral("{b5e1f000-2a3c-4d5e-8f90-1a2b3c4d5e6f}"));
+}
+
+QBluetoothUuid GattUploader::controlCharacteristicUuid()
+{
+    return QBluetoothUuid(QStringLiteral("{b5e1f001-2a3c-4d5e-8f90-1a2b3c4d5e6f}"));
+}
+
+QBluetoothUuid GattUploader::dataCharacteristicUuid()
+{
+    return QBluetoothUuid(QStringLiteral("{b5e1f002-2a3c-4d5e-8f90-1a2b3c4d5e6f}"));
+}
+
+// 以只读方式映射文件，并计算整体 CRC 供设备判断能否续传
+bool GattUploader::openFile(const QString &path, quint8 uploadTarget)
+{
+    releaseSource();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "无法打开上传文件:" << path;
+        return false;
+    }
+    const qint64 fileSize = file.size();
+    uchar *mapped = fileSize > 0 ? file.map(0, fileSize) : nullptr;
+    if (!mapped) {
+        qDebug() << "无法映射上传文件:" << path;
+        file.close();
+        return false;
+    }
+
+    source = mapped;
+    size = fileSize;
+    target = uploadTarget;
+    imageCrc = crc32(source, size);
+    return true;
+}
+
+void GattUploader::setData(const QByteArray &data, quint8 uploadTarget)
+{
+    releaseSource();
+    ownedData = data;
+    source = reinterpret_cast<const uchar *>(ownedData.constData());
+    size = ownedData.size();
+    target = uploadTarget;
+    imageCrc = crc32(source, size);
+}
+
+void GattUploader::setMtu(int value)
+{
+    mtu = qMax(23, value);
+}
+
+void GattUploader::releaseSource()
+{
+    if (file.isOpen()) {
+        if (source)
+            file.unmap(const_cast<uchar *>(source));
+        file.close();
+    }
+    ownedData.clear();
+    source = nullptr;
+    size = 0;
+    imageCrc = 0;
+    currentState = Idle;
+    sendOffset = 0;
+    ackedOffset = 0;
+}
+
+bool GattUploader::start(QLowEnergyService *newService,
+                         const QLowEnergyCharacteristic &control,
+                         const QLowEnergyCharacteristic &data)
+{
+    if (!source || !newService || !control.isValid() || !data.isValid()) return false;
+    if (!(control.properties() & QLowEnergyCharacteristic::Write)) return false;
+    if (!(data.properties() & (QLowEnergyCharacteristic::Write | QLowEnergyCharacteristic::WriteNoResponse))) return false;
+    if (currentState == Starting || currentState == Streaming || currentState == Finishing) return false;
+
+    if (service)
+        disconnect(service.data(), nullptr, this, nullptr);
+    if (currentState != Paused) {
+        sendOffset = 0;
+        ackedOffset = 0;
+    }
+
+    service = newService;
+    controlCharacteristic = control;
+    dataCharacteristic = data;
+    // 按特征实际支持的属性选择写入方式
+    dataWriteMode = (data.properties() & QLowEnergyCharacteristic::WriteNoResponse)
+            ? QLowEnergyService::WriteWithoutResponse : QLowEnergyService::WriteWithResponse;
+    connect(newService, &QLowEnergyService::characteristicChanged,
+            this, &GattUploader::characteristicChanged);
+    connect(newService, &QLowEnergyService::characteristicWritten,
+            this, &GattUploader::characteristicWritten);
+    connect(newService, QOverload<QLowEnergyService::ServiceError>::of(&QLowEnergyService::error),
+            this, &GattUploader::serviceError);
+
+    // 订阅控制特征的通知，设备通过它返回确认
+    const QLowEnergyDescriptor cccd = control.descriptor(QBluetoothUuid::ClientCharacteristicConfiguration);
+    if (cccd.isValid())
+        service->writeDescriptor(cccd, QByteArray::fromHex("0100"));
+
+    TraceRecorder::asyncBegin("upload", reinterpret_cast<quintptr>(this));
+    currentState = Starting;
+    retries = 0;
+    sendBegin();
+    return true;
+}
+
+// 发送 BEGIN，设备以 READY 回复续传偏移
+void GattUploader::sendBegin()
+{
+    QByteArray begin(10, Qt::Uninitialized);
+    begin[0] = static_cast<char>(OpBegin);
+    begin[1] = static_cast<char>(target);
+    putUint32(begin.data() + 2, static_cast<quint32>(size));
+    putUint32(begin.data() + 6, imageCrc);
+    sendCommand(begin);
+    ackTimer->start(kAckTimeoutMs);
+}
+
+void GattUploader::pause()
+{
+    if (currentState != Starting && currentState != Streaming && currentState != Finishing) return;
+
+    ackTimer->stop();
+    dropPendingWrites();
+    if (service)
+        disconnect(service.data(), nullptr, this, nullptr);
+    service = nullptr;
+    sendOffset = ackedOffset;  // 未确认的块在续传时重发
+    currentState = Paused;
+    TraceRecorder::asyncEnd("upload", reinterpret_cast<quintptr>(this));
+    qDebug() << "上传已暂停，已确认" << ackedOffset << "/" << size << "字节";
+}
+
+void GattUploader::abort()
+{
+    if (currentState == Idle || currentState == Finished || currentState == Failed) return;
+
+    if (service && currentState != Paused)
+        sendCommand(QByteArray(1, static_cast<char>(OpAbort)));
+    ackTimer->stop();
+    dropPendingWrites();
+    if (service)
+        disconnect(service.data(), nullptr, this, nullptr);
+    service = nullptr;
+    if (currentState != Paused)
+        TraceRecorder::asyncEnd("upload", reinterpret_cast<quintptr>(this));
+    currentState = Idle;
+    sendOffset = 0;
+    ackedOffset = 0;
+}
+
+// 每个 ATT 包能携带的数据字节数
+int GattUploader::chunkPayload() const
+{
+    return mtu - kAttHeaderSize - kDataHeaderSize;
+}
+
+// 一个窗口的发送时间随 MTU 和写入方式变化，确认超时按窗口内的包数放宽
+int GattUploader::streamTimeoutMs() const
+{
+    const int packetsPerBlock = (kBlockSize + chunkPayload() - 1) / chunkPayload() + 1;  // 含 BLOCK_END
+    const int packetMs = dataWriteMode == QLowEnergyService::WriteWithResponse ? kResponsePacketMs : kPacketMs;
+    return kAckTimeoutMs + kWindowBlocks * packetsPerBlock * packetMs;
+}
+
+// 在窗口允许的范围内继续发送数据块
+void GattUploader::pump()
+{
+    if (currentState != Streaming) return;
+
+    const qint64 window = static_cast<qint64>(kWindowBlocks) * kBlockSize;
+    while (sendOffset < size && sendOffset - ackedOffset < window) {
+        sendBlock(sendOffset);
+        sendOffset += qMin<qint64>(kBlockSize, size - sendOffset);
+    }
+
+    if (ackedOffset >= size) {
+        currentState = Finishing;
+        sendCommand(QByteArray(1, static_cast<char>(OpFinish)));
+        ackTimer->start(kAckTimeoutMs);
+    } else if (!ackTimer->isActive()) {
+        ackTimer->start();
+    }
+}
+
+// 发送一个数据块：若干 DATA 包加一个带 CRC 的 BLOCK_END
+void GattUploader::sendBlock(qint64 offset)
+{
+    TRACE_SCOPE("uploadBlock");
+    const int length = static_cast<int>(qMin<qint64>(kBlockSize, size - offset));
+    const int payload = chunkPayload();
+
+    for (int pos = 0; pos < length; pos += payload) {
+        const int n = qMin(payload, length - pos);
+        QByteArray packet(kDataHeaderSize + n, Qt::Uninitialized);
+        packet[0] = static_cast<char>(OpData);
+        putUint32(packet.data() + 1, static_cast<quint32>(offset + pos));
+        memcpy(packet.data() + kDataHeaderSize, source + offset + pos, n);
+        writePacket(dataCharacteristic, packet);
+    }
+
+    QByteArray blockEnd(13, Qt::Uninitialized);
+    blockEnd[0] = static_cast<char>(OpBlockEnd);
+    putUint32(blockEnd.data() + 1, static_cast<quint32>(offset));
+    putUint32(blockEnd.data() + 5, static_cast<quint32>(length));
+    putUint32(blockEnd.data() + 9, crc32(source + offset, length));
+    writePacket(controlCharacteristic, blockEnd);
+}
+
+// 无响应写直接交给 Qt 排队；有响应写逐个发出，收到 characteristicWritten 后再发下一个，
+// 这样超时或 NAK 时尚未发出的包可以直接丢弃，不会在 Qt 的队列中堆积重复数据
+void GattUploader::writePacket(const QLowEnergyCharacteristic &characteristic, const QByteArray &packet)
+{
+    if (dataWriteMode == QLowEnergyService::WriteWithoutResponse) {
+        service->writeCharacteristic(characteristic, packet,
+                                     characteristic.uuid() == dataCharacteristic.uuid()
+                                     ? QLowEnergyService::WriteWithoutResponse
+                                     : QLowEnergyService::WriteWithResponse);
+        return;
+    }
+
+    PendingWrite write = { characteristic, packet };
+    pendingWrites.append(write);
+    writeNext();
+}
+
+void GattUploader::writeNext()
+{
+    if (writeInFlight || pendingWrites.isEmpty() || !service) return;
+
+    const PendingWrite write = pendingWrites.takeFirst();
+    writeInFlight = true;
+    service->writeCharacteristic(write.characteristic, write.value);
+}
+
+void GattUploader::dropPendingWrites()
+{
+    pendingWrites.clear();
+    writeInFlight = false;
+}
+
+void GattUploader::sendCommand(const QByteArray &command)
+{
+    if (!service) return;
+    service->writeCharacteristic(controlCharacteristic, command);
+}
+
+// 处理设备通过控制特征发回的通知
+void GattUploader::characteristicChanged(const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
+{
+    if (characteristic.uuid() != controlCharacteristic.uuid() || value.isEmpty()) return;
+
+    const quint8 opcode = static_cast<quint8>(value.at(0));
+    const bool hasOffset = value.size() >= 5;
+    const qint64 offset = hasOffset
+            ? qMin<qint64>(qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(value.constData() + 1)), size)
+            : 0;
+
+    switch (opcode) {
+        case OpReady:
+            if (currentState != Starting || !hasOffset) break;
+            // 续传偏移对齐到块边界
+            ackedOffset = offset - offset % kBlockSize;
+            sendOffset = ackedOffset;
+            sessionStartOffset = ackedOffset;
+            retries = 0;
+            throughputTimer.start();
+            currentState = Streaming;
+            ackTimer->start(streamTimeoutMs());  // BEGIN 的超时不再适用
+            qDebug() << "开始上传，续传偏移:" << ackedOffset << "总长度:" << size;
+            emit progress(ackedOffset, size, 0.0);
+            pump();
+            break;
+        case OpBlockAck:
+            if (currentState != Streaming || !hasOffset) break;
+            if (offset > ackedOffset) {
+                ackedOffset = offset;
+                retries = 0;
+                ackTimer->start();
+                const qint64 elapsed = qMax<qint64>(1, throughputTimer.elapsed());
+                emit progress(ackedOffset, size, (ackedOffset - sessionStartOffset) * 1000.0 / elapsed);
+            }
+            pump();
+            break;
+        case OpBlockNak:
+            if (currentState != Streaming || !hasOffset) break;
+            // 回退重传；只接受落在已发送未确认区间内的 NAK
+            if (offset >= ackedOffset && offset < sendOffset) {
+                qDebug() << "块校验失败，从偏移" << offset << "重传";
+                sendOffset = offset - offset % kBlockSize;
+                pendingWrites.clear();  // 排队中的包都属于需重传的块
+            }
+            pump();
+            break;
+        case OpDone:
+            if (currentState != Finishing) break;
+            ackTimer->stop();
+            // 之后 RUN/STOP 仍使用同一控制特征，不再接收它的通知和错误
+            disconnect(service.data(), nullptr, this, nullptr);
+            service = nullptr;
+            currentState = Finished;
+            TraceRecorder::asyncEnd("upload", reinterpret_cast<quintptr>(this));
+            qDebug() << "上传完成:" << size << "字节";
+            emit finished();
+            break;
+        case OpError:
+            fail(QString("设备返回错误码 %1").arg(value.size() > 1 ? static_cast<quint8>(value.at(1)) : 0));
+            break;
+        default:
+            break;
+    }
+}
+
+// 有响应写完成：发出下一个包；写入仍在推进说明链路正常，顺延确认超时
+void GattUploader::characteristicWritten(const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
+{
+    Q_UNUSED(value);
+    if (!writeInFlight) return;
+    if (characteristic.uuid() != dataCharacteristic.uuid()
+            && characteristic.uuid() != controlCharacteristic.uuid()) return;
+
+    writeInFlight = false;
+    if (currentState == Streaming)
+        ackTimer->start();
+    writeNext();
+}
+
+void GattUploader::serviceError(QLowEnergyService::ServiceError error)
+{
+    if (error == QLowEnergyService::CharacteristicWriteError
+            || error == QLowEnergyService::DescriptorWriteError) {
+        fail(QString("GATT 写入失败: %1").arg(error));
+    }
+}
+
+// 超时未收到确认：重发 BEGIN / FINISH，或从已确认偏移处重传
+void GattUploader::ackTimeout()
+{
+    if (++retries > kMaxRetries) {
+        fail("设备无响应");
+        return;
+    }
+
+    switch (currentState) {
+        case Starting:
+            sendBegin();
+            break;
+        case Streaming:
+            dropPendingWrites();  // 已交给 Qt 的写入无法撤回，至多重复当前这一个包
+            sendOffset = ackedOffset;
+            pump();
+            break;
+        case Finishing:
+            sendCommand(QByteArray(1, static_cast<char>(OpFinish)));
+            ackTimer->start(kAckTimeoutMs);
+            break;
+        default:
+            break;
+    }
+}
+
+void GattUploader::fail(const QString &reason)
+{
+    if (currentState != Starting && currentState != Streaming
+            && currentState != Finishing && currentState != Paused) return;
+
+    ackTimer->stop();
+    dropPendingWrites();
+    if (service)
+        disconnect(service.data(), nullptr, this, nullptr);
+    service = nullptr;
+    if (currentState != Paused)
+        TraceRecorder::asyncEnd("upload", reinterpret_cast<quintptr>(this));
+    currentState = Failed;
+    qDebug() << "上传失败:" << reason;
+    emit failed(reason);
+}
+
+// 标准 CRC-32（IEEE 802.3），crc 参数用于分段累计
+quint32 GattUploader::crc32(const uchar *data, qint64 length, quint32 crc)
+{
+    static const struct Table {
+        quint32 entries[256];
+        Table()
+        {
+            for (quint32 i = 0; i < 256; ++i) {
+                quint32 c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+                entries[i] = c;
+            }
+        }
+    } table;
+
+    crc = ~crc;
+    for (qint64 i = 0; i < length; ++i)
+        crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QList>
+#include <QLowEnergyService>
+
+// GATT 分块上传引擎：把固件或配置文件按 MTU 切块，流水线写入 ESP32
+//
+// 上传使用独立的 GATT 服务，与机器人 2 字节运动命令所在的特征分开：
+//   服务      b5e1f000-2a3c-4d5e-8f90-1a2b3c4d5e6f
+//   控制特征  b5e1f001-2a3c-4d5e-8f90-1a2b3c4d5e6f  Write + Notify
+//   数据特征  b5e1f002-2a3c-4d5e-8f90-1a2b3c4d5e6f  WriteWithoutResponse（不支持时退回有响应写）
+//
+// 协议（小端字节序）：
+//   主机 -> 设备  0x01 BEGIN     [u8 目标][u32 总长度][u32 整体 CRC32]
+//                 0x02 DATA      [u32 偏移][数据]
+//                 0x03 BLOCK_END [u32 块偏移][u32 块长度][u32 块 CRC32]
+//                 0x04 FINISH
+//                 0x05 ABORT
+//                 0x06 RUN / 0x07 STOP  运行/停止已上传的动作程序（见 motion_program.h）
+//   设备 -> 主机  0x81 READY     [u32 续传偏移]  相同 CRC 的未完成镜像返回已提交的偏移，否则为 0
+//                 0x82 BLOCK_ACK [u32 已提交偏移]
+//                 0x83 BLOCK_NAK [u32 需重传的偏移]
+//                 0x84 DONE
+//                 0x85 ERROR     [u8 错误码]
+class GattUploader : public QObject {
+    Q_OBJECT
+
+public:
+    enum Target : quint8 {
+        Firmware = 0,
+        Config = 1,
+        MotionProgram = 2  // 动作脚本字节码，见 motion_program.h
+    };
+
+    enum State {
+        Idle,
+        Starting,
+        Streaming,
+        Finishing,
+        Paused,
+        Finished,
+        Failed
+    };
+
+    explicit GattUploader(QObject *parent = nullptr);
+    ~GattUploader();
+
+    static QBluetoothUuid serviceUuid();
+    static QBluetoothUuid controlCharacteristicUuid();
+    static QBluetoothUuid dataCharacteristicUuid();
+
+    bool openFile(const QString &path, quint8 target);  // 内存映射文件，不整体读入
+    void setData(const QByteArray &data, quint8 target);  // 小数据直接从内存上传
+    void setMtu(int mtu);
+
+    // 开始上传；处于 Paused 状态时从设备报告的偏移处续传
+    bool start(QLowEnergyService *service,
+               const QLowEnergyCharacteristic &controlCharacteristic,
+               const QLowEnergyCharacteristic &dataCharacteristic);
+    void pause();  // 连接断开时调用，保留进度等待续传
+    void abort();
+
+    State state() const { return currentState; }
+    qint64 totalBytes() const { return size; }
+    qint64 ackedBytes() const { return ackedOffset; }
+
+    static quint32 crc32(const uchar *data, qint64 length, quint32 crc = 0);
+
+signals:
+    void progress(qint64 ackedBytes, qint64 totalBytes, double bytesPerSecond);
+    void finished();
+    void failed(const QString &reason);
+
+private slots:
+    void characteristicChanged(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
+    void characteristicWritten(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
+    void serviceError(QLowEnergyService::ServiceError error);
+    void ackTimeout();
+
+private:
+    void releaseSource();
+    void sendBegin();
+    void pump();
+    void sendBlock(qint64 offset);
+    void writePacket(const QLowEnergyCharacteristic &characteristic, const QByteArray &packet);
+    void writeNext();
+    void dropPendingWrites();
+    void sendCommand(const QByteArray &command);
+    void fail(const QString &reason);
+    int chunkPayload() const;
+    int streamTimeoutMs() const;
+
+    QFile file;
+    QByteArray ownedData;
+    const uchar *source;
+    qint64 size;
+    quint32 imageCrc;
+    quint8 target;
+
+    int mtu;
+
+    QPointer<QLowEnergyService> service;
+    QLowEnergyCharacteristic controlCharacteristic;
+    QLowEnergyCharacteristic dataCharacteristic;
+    QLowEnergyService::WriteMode dataWriteMode;
+
+    struct PendingWrite {
+        QLowEnergyCharacteristic characteristic;
+        QByteArray value;
+    };
+    QList<PendingWrite> pendingWrites;  // 有响应写模式下尚未交给 Qt 的包
+    bool writeInFlight;
+
+    State currentState;
+    qint64 sendOffset;   // 下一个待发送块的偏移
+    qint64 ackedOffset;  // 设备已确认提交的偏移
+    int retries;
+    QTimer *ackTimer;
+    QElapsedTimer throughputTimer;
+    qint64 sessionStartOffset;
+};
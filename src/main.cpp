@@ -1,8 +1,19 @@
 #include <QApplication>
 #include "bluetooth_connector.h"
+#include "trace_recorder.h"
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
+    
+    // 设置 BLE_TRACE=<文件路径> 时从启动开始记录，退出时导出
+    const QString tracePath = qEnvironmentVariable("BLE_TRACE");
+    if (!tracePath.isEmpty()) {
+        TraceRecorder::setEnabled(true);
+        QObject::connect(&app, &QApplication::aboutToQuit, [tracePath]() {
+            TraceRecorder::dump(tracePath);
+        });
+    }
+    
     BluetoothConnector window;
     window.setWindowTitle("蓝牙控制器");
     window.resize(600, 700);
@@ -0,0 +1,148 @@
+#include "motion_program.h"
+#include "command_schema.h"
+#include <QRegularExpression>
+#include <QStringList>
+#include <QVector>
+
+namespace {
+
+enum Instruction : quint8 {
+    OpHalt = 0x00,
+    OpKey = 0x10,
+    OpHold = 0x11,
+    OpLoop = 0x20,
+    OpEndLoop = 0x21
+};
+
+const quint8 kBytecodeVersion = 1;
+const qint64 kDurationCap = Q_INT64_C(1) << 40;  // 累计时长上限，防止嵌套循环相乘溢出
+
+// 尚未闭合的 loop：所在行号、次数和循环体一次执行的总时长
+struct OpenLoop {
+    int line;
+    int count;
+    qint64 durationMs;
+};
+
+// 解析整数参数并检查范围
+bool parseInt(const QString &token, int min, int max, int &value)
+{
+    bool ok;
+    value = token.toInt(&ok);
+    return ok && value >= min && value <= max;
+}
+
+// 追加一条指令：操作码加按 Operands 格式编码的操作数
+template <typename Operands, typename... Values>
+bool appendInstruction(QByteArray &out, quint8 opcode, Values... values)
+{
+    typename Operands::Buffer operands;
+    if (!Operands::encode(operands, values...))
+        return false;
+    out.append(static_cast<char>(opcode));
+    out.append(reinterpret_cast<const char *>(operands.data()), static_cast<int>(Operands::size));
+    return true;
+}
+
+bool setError(QString *error, int line, const QString &message)
+{
+    if (error)
+        *error = QString("第 %1 行: %2").arg(line).arg(message);
+    return false;
+}
+
+} // namespace
+
+bool MotionProgram::compile(const QString &source, QByteArray &bytecode, QString *error)
+{
+    QByteArray out;
+    out.append('K');
+    out.append('P');
+    out.append(static_cast<char>(kBytecodeVersion));
+    out.append('\0');
+
+    const QStringList lines = source.split('\n');
+    QVector<OpenLoop> openLoops;
+
+    for (int i = 0; i < lines.size(); ++i) {
+        const int lineNumber = i + 1;
+        QString line = lines.at(i);
+        const int comment = line.indexOf('#');
+        if (comment >= 0)
+            line.truncate(comment);
+
+        // 手动去掉空元素，兼容 Qt 5.14 之前没有 Qt::SkipEmptyParts 的版本
+        QStringList tokens = line.split(QRegularExpression("\\s+"));
+        tokens.removeAll(QString());
+        if (tokens.isEmpty()) continue;
+
+        const QString op = tokens.first().toLower();
+        if (op == "key") {
+            int forward, turn, ms;
+            if (tokens.size() != 4)
+                return setError(error, lineNumber, "key 需要 3 个参数: <forward> <turn> <ms>");
+            if (!parseInt(tokens.at(1), ForwardField::minimum(), ForwardField::maximum(), forward))
+                return setError(error, lineNumber, QString("forward 超出范围 (%1..%2)")
+                                .arg(ForwardField::minimum()).arg(ForwardField::maximum()));
+            if (!parseInt(tokens.at(2), TurnField::minimum(), TurnField::maximum(), turn))
+                return setError(error, lineNumber, QString("turn 超出范围 (%1..%2)")
+                                .arg(TurnField::minimum()).arg(TurnField::maximum()));
+            if (!parseInt(tokens.at(3), DurationField::minimum(), DurationField::maximum(), ms))
+                return setError(error, lineNumber, QString("时长超出范围 (%1..%2 ms)")
+                                .arg(DurationField::minimum()).arg(DurationField::maximum()));
+            appendInstruction<KeyframeOperands>(out, OpKey, forward, turn, ms);
+            if (!openLoops.isEmpty())
+                openLoops.last().durationMs += ms;
+        } else if (op == "hold") {
+            int ms;
+            if (tokens.size() != 2 || !parseInt(tokens.at(1), HoldField::minimum(), HoldField::maximum(), ms)
+                    || !appendInstruction<HoldOperands>(out, OpHold, ms))
+                return setError(error, lineNumber, QString("hold 需要 1 个参数: <ms> (%1..%2)")
+                                .arg(HoldField::minimum()).arg(HoldField::maximum()));
+            if (!openLoops.isEmpty())
+                openLoops.last().durationMs += ms;
+        } else if (op == "loop") {
+            int count;
+            if (tokens.size() != 2 || !parseInt(tokens.at(1), LoopCountField::minimum(), LoopCountField::maximum(), count))
+                return setError(error, lineNumber, QString("loop 需要 1 个参数: <n> (%1..%2，0 为无限循环)")
+                                .arg(LoopCountField::minimum()).arg(LoopCountField::maximum()));
+            if (openLoops.size() >= MaxLoopDepth)
+                return setError(error, lineNumber, QString("循环嵌套超过 %1 层").arg(MaxLoopDepth));
+            OpenLoop loop = { lineNumber, count, 0 };
+            openLoops.append(loop);
+            appendInstruction<LoopOperands>(out, OpLoop, count);
+        } else if (op == "end") {
+            if (tokens.size() != 1)
+                return setError(error, lineNumber, "end 不需要参数");
+            if (openLoops.isEmpty())
+                return setError(error, lineNumber, "end 没有对应的 loop");
+            const OpenLoop loop = openLoops.takeLast();
+            // 零时长的无限循环会让固件执行器空转，无法响应 STOP
+            if (loop.count == 0 && loop.durationMs == 0)
+                return setError(error, loop.line, "无限循环的循环体总时长必须大于 0 ms");
+            if (!openLoops.isEmpty()) {
+                const qint64 total = loop.count == 0 ? loop.durationMs
+                                                     : loop.durationMs * loop.count;
+                openLoops.last().durationMs = qMin(kDurationCap, openLoops.last().durationMs + total);
+            }
+            out.append(static_cast<char>(OpEndLoop));
+        } else {
+            return setError(error, lineNumber, "未知指令: " + tokens.first());
+        }
+
+        if (out.size() >= MaxProgramSize)
+            return setError(error, lineNumber, QString("程序超过 %1 字节").arg(MaxProgramSize));
+    }
+
+    if (!openLoops.isEmpty())
+        return setError(error, openLoops.last().line, "loop 缺少对应的 end");
+
+    out.append(static_cast<char>(OpHalt));
+    bytecode = out;
+    return true;
+}
+
+QByteArray MotionProgram::command(Command type)
+{
+    return QByteArray(1, static_cast<char>(type));
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// 动作脚本编译器：把文本动作脚本编译成紧凑字节码，一次性上传后由固件本地执行
+//
+// 脚本语法（每行一条，# 之后为注释）：
+//   key <forward> <turn> <ms>   在 ms 毫秒内线性过渡到该关键帧（forward -100..100，turn -90..90）
+//   hold <ms>                   保持当前动作 ms 毫秒
+//   loop <n>                    循环开始，n 为次数，0 表示无限循环（循环体总时长须大于 0，最多嵌套 8 层）
+//   end                         循环结束
+//
+// 字节码（小端字节序）：
+//   头部 'K' 'P' [u8 版本] [u8 保留]
+//   0x10 KEY  [i8 forward][i8 turn][u16 ms]
+//   0x11 HOLD [u16 ms]
+//   0x20 LOOP [u8 n]
+//   0x21 END_LOOP
+//   0x00 HALT
+//
+// 上传使用 GattUploader::MotionProgram 目标，运行/停止通过控制特征发送单字节命令
+class MotionProgram {
+public:
+    enum Command : quint8 {
+        Run = 0x06,
+        Stop = 0x07
+    };
+
+    static const int MaxProgramSize = 4096;
+    static const int MaxLoopDepth = 8;
+
+    // 编译成功返回 true；失败时 error 中包含行号和原因
+    static bool compile(const QString &source, QByteArray &bytecode, QString *error = nullptr);
+    static QByteArray command(Command type);
+};
@@ -0,0 +1,74 @@
+#include "scan_filter.h"
+
+ScanFilter::ScanFilter()
+    : hasManufacturer(false), manufacturerId(0), expected(1)
+{
+}
+
+// 设置广播名称的正则表达式，空字符串表示不按名称过滤
+bool ScanFilter::setNamePattern(const QString &pattern)
+{
+    const QRegularExpression expression(pattern, QRegularExpression::CaseInsensitiveOption);
+    if (pattern.isEmpty() || !expression.isValid()) {
+        namePattern = QRegularExpression();
+        return pattern.isEmpty();
+    }
+    namePattern = expression;
+    return true;
+}
+
+// 设置厂商 ID，prefix 非空时还要求厂商数据以其开头
+void ScanFilter::setManufacturerData(quint16 id, const QByteArray &prefix)
+{
+    hasManufacturer = true;
+    manufacturerId = id;
+    manufacturerPrefix = prefix;
+}
+
+void ScanFilter::setServiceUuid(const QBluetoothUuid &uuid)
+{
+    serviceUuid = uuid;
+}
+
+// 设置期望的设备数量，小于等于 0 表示不提前结束
+void ScanFilter::setExpectedCount(int count)
+{
+    expected = count;
+}
+
+void ScanFilter::clear()
+{
+    namePattern = QRegularExpression();
+    hasManufacturer = false;
+    manufacturerId = 0;
+    manufacturerPrefix.clear();
+    serviceUuid = QBluetoothUuid();
+}
+
+bool ScanFilter::isActive() const
+{
+    return !namePattern.pattern().isEmpty() || hasManufacturer || !serviceUuid.isNull();
+}
+
+// 检查设备是否满足所有已设置的过滤条件
+bool ScanFilter::matches(const QBluetoothDeviceInfo &device) const
+{
+    if (!(device.coreConfigurations() & QBluetoothDeviceInfo::LowEnergyCoreConfiguration))
+        return false;
+
+    if (!namePattern.pattern().isEmpty() && !namePattern.match(device.name()).hasMatch())
+        return false;
+
+    if (hasManufacturer) {
+        const QByteArray data = device.manufacturerData(manufacturerId);
+        if (data.isEmpty() && !device.manufacturerIds().contains(manufacturerId))
+            return false;
+        if (!data.startsWith(manufacturerPrefix))
+            return false;
+    }
+
+    if (!serviceUuid.isNull() && !device.serviceUuids().contains(serviceUuid))
+        return false;
+
+    return true;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QBluetoothDeviceInfo>
+#include <QBluetoothUuid>
+#include <QByteArray>
+#include <QRegularExpression>
+
+// 扫描过滤器：按广播名称、厂商数据或服务 UUID 匹配目标设备
+// 任一已设置的条件都必须满足；未设置任何条件时匹配所有 BLE 设备
+class ScanFilter {
+public:
+    ScanFilter();
+
+    bool setNamePattern(const QString &pattern);  // 正则无效时返回 false，不按名称过滤
+    void setManufacturerData(quint16 manufacturerId, const QByteArray &prefix = QByteArray());
+    void setServiceUuid(const QBluetoothUuid &uuid);
+    void setExpectedCount(int count);
+    void clear();
+
+    bool isActive() const;
+    int expectedCount() const { return expected; }
+    bool matches(const QBluetoothDeviceInfo &device) const;
+
+private:
+    QRegularExpression namePattern;
+    bool hasManufacturer;
+    quint16 manufacturerId;
+    QByteArray manufacturerPrefix;
+    QBluetoothUuid serviceUuid;
+    int expected;  // 匹配到多少台设备后提前结束扫描
+};
@@ -0,0 +1,165 @@
+#include "state_poller.h"
+#include "trace_recorder.h"
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+const int kTickMs = 100;           // 调度粒度；间隔相近的读取在同一轮发出
+const int kReadTimeoutMs = 2000;   // 读取无响应时允许重新发出
+
+} // namespace
+
+StatePoller::StatePoller(QObject *parent)
+    : QObject(parent)
+{
+    pollTimer = new QTimer(this);
+    pollTimer->setInterval(kTickMs);
+    connect(pollTimer, &QTimer::timeout, this, &StatePoller::poll);
+    clock.start();
+}
+
+void StatePoller::watch(const QBluetoothUuid &characteristic, int intervalMs)
+{
+    Entry &entry = entries[characteristic];
+    entry.intervals.append(qMax(kTickMs, intervalMs));
+    if (!entry.characteristic.isValid())
+        bind(characteristic, entry);
+    updateTimer();
+}
+
+void StatePoller::unwatch(const QBluetoothUuid &characteristic, int intervalMs)
+{
+    auto it = entries.find(characteristic);
+    if (it == entries.end()) return;
+    it->intervals.removeOne(qMax(kTickMs, intervalMs));  // 缓存保留，只是不再轮询
+    updateTimer();
+}
+
+// 记录服务，并绑定其中已被关注的特征
+void StatePoller::addService(QLowEnergyService *service)
+{
+    if (!service || services.contains(service)) return;
+
+    services.append(service);
+    connect(service, &QLowEnergyService::characteristicRead,
+            this, &StatePoller::characteristicRead);
+    connect(service, &QLowEnergyService::characteristicChanged,
+            this, &StatePoller::characteristicChanged);
+
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (!it->characteristic.isValid())
+            bind(it.key(), it.value());
+    }
+}
+
+void StatePoller::clearServices()
+{
+    for (const QPointer<QLowEnergyService> &service : services) {
+        if (service)
+            disconnect(service.data(), nullptr, this, nullptr);
+    }
+    services.clear();
+
+    // 下一次连接的可能是另一台设备，旧值既不能显示也不能推迟读取
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        it->service = nullptr;
+        it->characteristic = QLowEnergyCharacteristic();
+        it->cache = CachedValue();
+        it->updatedAt = 0;
+        it->readPending = false;
+    }
+}
+
+StatePoller::CachedValue StatePoller::value(const QBluetoothUuid &characteristic) const
+{
+    return entries.value(characteristic).cache;
+}
+
+// 在已记录的服务中查找可读或可通知的特征
+void StatePoller::bind(const QBluetoothUuid &uuid, Entry &entry)
+{
+    for (const QPointer<QLowEnergyService> &service : services) {
+        if (!service) continue;
+        const QLowEnergyCharacteristic characteristic = service->characteristic(uuid);
+        if (characteristic.isValid() && (characteristic.properties()
+                & (QLowEnergyCharacteristic::Read | QLowEnergyCharacteristic::Notify))) {
+            entry.service = service;
+            entry.characteristic = characteristic;
+            return;
+        }
+    }
+}
+
+// 找出本轮到期的特征，连续发出读取请求
+void StatePoller::poll()
+{
+    const qint64 now = clock.elapsed();
+    QList<Entry *> due;
+
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        Entry &entry = it.value();
+        if (entry.intervals.isEmpty() || !entry.service || !entry.characteristic.isValid()) continue;
+        if (entry.service->state() != QLowEnergyService::ServiceDiscovered) continue;
+        if (!(entry.characteristic.properties() & QLowEnergyCharacteristic::Read)) continue;
+        if (entry.readPending && now - entry.readIssuedAt < kReadTimeoutMs) continue;
+
+        // 间隔内已由读取或通知更新过的值不再读取；
+        // 提前半个调度周期视为到期，让间隔相近的读取合并到同一轮
+        const int interval = *std::min_element(entry.intervals.begin(), entry.intervals.end());
+        if (entry.cache.isValid() && now - entry.updatedAt < interval - kTickMs / 2) continue;
+
+        due.append(&entry);
+    }
+
+    if (due.isEmpty()) return;
+
+    TRACE_SCOPE("pollReads");
+    for (Entry *entry : due) {
+        entry->readPending = true;
+        entry->readIssuedAt = now;
+        entry->service->readCharacteristic(entry->characteristic);
+    }
+}
+
+void StatePoller::characteristicRead(const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
+{
+    auto it = entries.find(characteristic.uuid());
+    if (it == entries.end()) return;
+    it->readPending = false;
+    store(characteristic.uuid(), value);
+}
+
+void StatePoller::characteristicChanged(const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
+{
+    if (!entries.contains(characteristic.uuid())) return;
+    store(characteristic.uuid(), value);
+}
+
+void StatePoller::store(const QBluetoothUuid &uuid, const QByteArray &value)
+{
+    Entry &entry = entries[uuid];
+    entry.cache.value = value;
+    entry.cache.timestamp = QDateTime::currentMSecsSinceEpoch();
+    entry.updatedAt = clock.elapsed();
+    emit valueUpdated(uuid, value, entry.cache.timestamp);
+}
+
+// 只有存在使用方时才运行定时器
+void StatePoller::updateTimer()
+{
+    bool active = false;
+    for (const Entry &entry : entries) {
+        if (!entry.intervals.isEmpty()) {
+            active = true;
+            break;
+        }
+    }
+
+    if (active && !pollTimer->isActive()) {
+        pollTimer->start();
+    } else if (!active) {
+        pollTimer->stop();
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QObject>
+#include <QMap>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QLowEnergyService>
+
+// 机器人状态轮询：定期读取一组可读特征，结果写入带时间戳的缓存
+//
+// - 多个使用方 watch 同一特征时只按最短间隔读取一次
+// - 同一轮中到期的读取连续发出，共享连接事件
+// - 通知已在间隔内更新过的值不再读取
+// - 界面直接读缓存，不产生额外的 BLE 流量
+class StatePoller : public QObject {
+    Q_OBJECT
+
+public:
+    struct CachedValue {
+        QByteArray value;
+        qint64 timestamp = 0;  // QDateTime::currentMSecsSinceEpoch()，仅供显示，0 表示尚无数据
+
+        bool isValid() const { return timestamp != 0; }
+    };
+
+    explicit StatePoller(QObject *parent = nullptr);
+
+    // 每次 watch 对应一个使用方，不再需要时用相同参数 unwatch
+    void watch(const QBluetoothUuid &characteristic, int intervalMs);
+    void unwatch(const QBluetoothUuid &characteristic, int intervalMs);
+
+    void addService(QLowEnergyService *service);  // 服务发现完成后绑定其中被关注的特征
+    void clearServices();                         // 断开连接时调用，同时清空缓存
+
+    CachedValue value(const QBluetoothUuid &characteristic) const;
+
+signals:
+    void valueUpdated(const QBluetoothUuid &characteristic, const QByteArray &value, qint64 timestamp);
+
+private slots:
+    void poll();
+    void characteristicRead(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
+    void characteristicChanged(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
+
+private:
+    struct Entry {
+        QList<int> intervals;  // 每个使用方请求的间隔
+        QPointer<QLowEnergyService> service;
+        QLowEnergyCharacteristic characteristic;
+        CachedValue cache;
+        qint64 updatedAt = 0;     // 单调时钟，用于调度
+        bool readPending = false;
+        qint64 readIssuedAt = 0;  // 单调时钟
+    };
+
+    void bind(const QBluetoothUuid &uuid, Entry &entry);
+    void store(const QBluetoothUuid &uuid, const QByteArray &value);
+    void updateTimer();
+
+    QMap<QBluetoothUuid, Entry> entries;  // 假定特征 UUID 在各服务间不重复
+    QList<QPointer<QLowEnergyService>> services;
+    QTimer *pollTimer;
+    QElapsedTimer clock;  // 调度和超时使用单调时钟，不受系统时间调整影响
+};
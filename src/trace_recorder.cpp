@@ -0,0 +1,141 @@
+#include "trace_recorder.h"
+
+#include <QFile>
+#include <QDebug>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> TraceRecorder::enabled(false);
+
+namespace {
+
+struct TraceEvent {
+    const char *name;
+    char phase;      // X: 完整事件, b/e: 异步开始/结束
+    qint64 ts;
+    qint64 duration;
+    quint64 id;
+};
+
+// 每个线程独占一个缓冲区；锁只在导出时才会有竞争
+struct ThreadBuffer {
+    std::mutex lock;
+    std::vector<TraceEvent> events;
+    int tid;
+};
+
+std::mutex registryLock;
+
+std::vector<std::unique_ptr<ThreadBuffer>> &registry()
+{
+    static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    return buffers;
+}
+
+thread_local ThreadBuffer *localBuffer = nullptr;
+
+ThreadBuffer *currentBuffer()
+{
+    if (!localBuffer) {
+        std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+        buffer->events.reserve(4096);
+        std::lock_guard<std::mutex> guard(registryLock);
+        buffer->tid = static_cast<int>(registry().size()) + 1;
+        localBuffer = buffer.get();
+        registry().push_back(std::move(buffer));  // 线程退出后缓冲区仍保留，便于导出
+    }
+    return localBuffer;
+}
+
+void record(const char *name, char phase, qint64 ts, qint64 duration, quint64 id)
+{
+    ThreadBuffer *buffer = currentBuffer();
+    TraceEvent event = { name, phase, ts, duration, id };
+    std::lock_guard<std::mutex> guard(buffer->lock);
+    buffer->events.push_back(event);
+}
+
+QByteArray escapeJson(const char *text)
+{
+    QByteArray out;
+    for (const char *p = text; *p; ++p) {
+        if (*p == '"' || *p == '\\')
+            out.append('\\');
+        out.append(*p);
+    }
+    return out;
+}
+
+} // namespace
+
+void TraceRecorder::setEnabled(bool on)
+{
+    nowUs();  // 确定时间原点
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+void TraceRecorder::complete(const char *name, qint64 startUs, qint64 durationUs)
+{
+    if (!isEnabled()) return;
+    record(name, 'X', startUs, durationUs, 0);
+}
+
+void TraceRecorder::asyncBegin(const char *name, quint64 id)
+{
+    if (!isEnabled()) return;
+    record(name, 'b', nowUs(), 0, id);
+}
+
+void TraceRecorder::asyncEnd(const char *name, quint64 id)
+{
+    if (!isEnabled()) return;
+    record(name, 'e', nowUs(), 0, id);
+}
+
+// 以首次调用为原点的单调时间（微秒）
+qint64 TraceRecorder::nowUs()
+{
+    static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - origin).count();
+}
+
+// 导出为 Chrome trace event 格式，可直接用 chrome://tracing 或 ui.perfetto.dev 打开
+bool TraceRecorder::dump(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "无法写入追踪文件:" << path;
+        return false;
+    }
+
+    QByteArray json("{\"traceEvents\":[");
+    bool first = true;
+    int count = 0;
+
+    std::lock_guard<std::mutex> registryGuard(registryLock);
+    for (const std::unique_ptr<ThreadBuffer> &buffer : registry()) {
+        std::lock_guard<std::mutex> guard(buffer->lock);
+        for (const TraceEvent &event : buffer->events) {
+            if (!first) json.append(",\n");
+            first = false;
+            json.append("{\"name\":\"").append(escapeJson(event.name))
+                .append("\",\"cat\":\"ble\",\"ph\":\"").append(event.phase)
+                .append("\",\"ts\":").append(QByteArray::number(event.ts))
+                .append(",\"pid\":1,\"tid\":").append(QByteArray::number(buffer->tid));
+            if (event.phase == 'X')
+                json.append(",\"dur\":").append(QByteArray::number(event.duration));
+            else
+                json.append(",\"id\":\"0x").append(QByteArray::number(event.id, 16)).append('"');
+            json.append('}');
+            ++count;
+        }
+    }
+    json.append("],\"displayTimeUnit\":\"ms\"}\n");
+
+    file.write(json);
+    qDebug() << "已导出" << count << "个追踪事件到" << path;
+    return true;
+}
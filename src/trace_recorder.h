@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+// 轻量级时序追踪：事件写入各线程自己的缓冲区，按需导出为 Chrome/Perfetto JSON
+// 关闭时每个追踪点只有一次原子读，几乎没有开销
+class TraceRecorder {
+public:
+    static void setEnabled(bool on);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // name 必须是字符串字面量（只保存指针）
+    static void complete(const char *name, qint64 startUs, qint64 durationUs);
+    static void asyncBegin(const char *name, quint64 id);
+    static void asyncEnd(const char *name, quint64 id);
+
+    static qint64 nowUs();
+    static bool dump(const QString &path);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// 作用域追踪：构造时记录开始时间，析构时写入一个完整事件
+class TraceScope {
+public:
+    explicit TraceScope(const char *name)
+        : spanName(TraceRecorder::isEnabled() ? name : nullptr),
+          startUs(spanName ? TraceRecorder::nowUs() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (spanName)
+            TraceRecorder::complete(spanName, startUs, TraceRecorder::nowUs() - startUs);
+    }
+
+private:
+    Q_DISABLE_COPY(TraceScope)
+
+    const char *spanName;
+    qint64 startUs;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)